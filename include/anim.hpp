@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <type_traits>
+#include <utils.hpp>
+#include <vec.hpp>
+
+namespace Pandora
+{
+    namespace Anim
+    {
+        enum class Interpolation : std::uint8_t
+        {
+            Step,
+            Linear,
+            CubicHermite, // Uses the tangents stored with each key
+            CatmullRom    // Tangents derived from the neighbouring keys
+        };
+
+        // Segment cache for one playback head. While time only moves forward the next segment
+        // is found by stepping from the cached key, so a whole clip costs O(1) per sample.
+        struct Cursor
+        {
+            std::size_t key{};
+        };
+
+        // Keyframes for track_count curves of vec<N, T> that share one time line.
+        // Values are stored as planes: for every key and component, the track_count values
+        // are contiguous, so a sample is a few scalar weights per call followed by a
+        // straight multiply-add loop over all tracks.
+        template <std::size_t N, typename T>
+        class TrackSet
+        {
+            static_assert(Utils::is_fp_v<T>, "[ERROR] Type \"T\" need a floating point");
+            static_assert( N > 0ULL, "[ERROR] The component number needs to be greater than zero");
+
+            public:
+                using value_type = T;
+                using size_type  = std::size_t;
+                using vec_type   = Vec::vec<N, T>;
+
+            public:
+
+                //////////////////////////////////////////// Constructors /////////////////////////////////////////////
+
+                explicit TrackSet(size_type track_count)
+                    : tracks_{ track_count }
+                {
+                }
+
+                //////////////////////////////////////// Functions in Class ///////////////////////////////////////////
+
+                constexpr size_type track_count() const { return tracks_; }
+                constexpr size_type key_count()   const { return times_.size(); }
+
+                constexpr float start_time() const { return times_.empty() ? 0.0f : times_.front(); }
+                constexpr float end_time()   const { return times_.empty() ? 0.0f : times_.back(); }
+
+                void reserve(size_type keys);
+
+                // Keys must be appended in strictly increasing time. tangents may be empty,
+                // in which case zero tangents are stored (only CubicHermite reads them).
+                void add_key(float time, std::span<const vec_type> values, std::span<const vec_type> tangents = {});
+
+                vec_type value(size_type key, size_type track) const;
+
+                // Find the segment holding time, updating cursor. Returns the local parameter in [0, 1].
+                float locate(Cursor& cursor, float time) const;
+
+                // Evaluate every track at time into out (out.size() == track_count()).
+                void sample(Cursor& cursor, float time, Interpolation mode, std::span<vec_type> out) const;
+
+            private:
+                template <std::size_t Taps>
+                void blend(const std::array<const T*, Taps>& planes, const std::array<T, Taps>& weights,
+                           std::span<vec_type> out) const;
+
+                constexpr const T* value_plane(size_type key) const { return values_.data() + key * N * tracks_; }
+                constexpr const T* tangent_plane(size_type key) const { return tangents_.data() + key * N * tracks_; }
+
+            private:
+                size_type          tracks_;
+                std::vector<float> times_;
+                std::vector<T>     values_;   // [key][component][track]
+                std::vector<T>     tangents_; // [key][component][track]
+        };
+
+        // Quaternion tracks stored as vec<4, T> (x, y, z, w).
+        // Each key is flipped onto the hemisphere of the previous one when it is added, so
+        // blending never takes the long way round; results are renormalized after blending.
+        // CubicHermite reads the tangents given to add_key (dq/dt, flipped along with their key).
+        template <typename T>
+        class RotationSet
+        {
+            public:
+                using value_type = T;
+                using size_type  = std::size_t;
+                using quat_type  = Vec::vec<4ULL, T>;
+
+            public:
+                explicit RotationSet(size_type track_count)
+                    : keys_{ track_count }
+                    , scratch_(track_count)
+                    , scratch_tangents_(track_count)
+                {
+                }
+
+                constexpr size_type track_count() const { return keys_.track_count(); }
+                constexpr size_type key_count()   const { return keys_.key_count(); }
+
+                void reserve(size_type keys) { keys_.reserve(keys); }
+
+                // tangents may be empty, in which case CubicHermite sees zero angular velocity
+                void add_key(float time, std::span<const quat_type> rotations, std::span<const quat_type> tangents = {});
+
+                void sample(Cursor& cursor, float time, Interpolation mode, std::span<quat_type> out) const;
+
+            private:
+                TrackSet<4ULL, T>      keys_;
+                std::vector<quat_type> scratch_;          // Hemisphere-corrected copy of the key being added
+                std::vector<quat_type> scratch_tangents_;
+        };
+
+        //////////////////////////////////////////// Member Functions /////////////////////////////////////////////////
+
+        template <std::size_t N, typename T>
+        void TrackSet<N, T>::reserve(size_type keys)
+        {
+            times_.reserve(keys);
+            values_.reserve(keys * N * tracks_);
+            tangents_.reserve(keys * N * tracks_);
+        }
+
+        template <std::size_t N, typename T>
+        void TrackSet<N, T>::add_key(float time, std::span<const vec_type> values, std::span<const vec_type> tangents)
+        {
+            assert(values.size() == tracks_);                       //"[ERROR] One value per track"
+            assert(tangents.empty() || tangents.size() == tracks_); //"[ERROR] One tangent per track"
+            assert(times_.empty() || time > times_.back());        //"[ERROR] Keys out of order"
+
+            const size_type base = values_.size();
+
+            times_.push_back(time);
+            values_.resize(base + N * tracks_);
+            tangents_.resize(base + N * tracks_, T{});
+
+            for (size_type comp{}; comp < N; ++comp)
+                for (size_type track{}; track < tracks_; ++track)
+                    values_[base + comp * tracks_ + track] = values[track][comp];
+
+            if (!tangents.empty())
+                for (size_type comp{}; comp < N; ++comp)
+                    for (size_type track{}; track < tracks_; ++track)
+                        tangents_[base + comp * tracks_ + track] = tangents[track][comp];
+        }
+
+        template <std::size_t N, typename T>
+        typename TrackSet<N, T>::vec_type TrackSet<N, T>::value(size_type key, size_type track) const
+        {
+            assert(key < key_count() && track < tracks_); //"[ERROR] Invalid index"
+
+            vec_type result;
+            const T* plane = value_plane(key);
+
+            for (size_type comp{}; comp < N; ++comp)
+                result[comp] = plane[comp * tracks_ + track];
+
+            return result;
+        }
+
+        template <std::size_t N, typename T>
+        float TrackSet<N, T>::locate(Cursor& cursor, float time) const
+        {
+            assert(!times_.empty()); //"[ERROR] Track has no keys"
+
+            const size_type last = times_.size() - 1;
+
+            if (last == 0 || time <= times_.front())
+            {
+                cursor.key = 0;
+                return 0.0f;
+            }
+
+            if (time >= times_[last])
+            {
+                cursor.key = last - 1;
+                return 1.0f;
+            }
+
+            // Forward playback: a short walk from the cached key, otherwise fall back to a search
+            constexpr size_type max_steps = 4;
+
+            size_type key = (cursor.key < last) ? cursor.key : 0;
+            bool found = false;
+
+            if (times_[key] <= time)
+                for (size_type step{}; step < max_steps; ++step, ++key)
+                    if (time < times_[key + 1])
+                    {
+                        found = true;
+                        break;
+                    }
+
+            if (!found)
+                key = static_cast<size_type>(std::upper_bound(times_.begin(), times_.end(), time) - times_.begin()) - 1;
+
+            cursor.key = key;
+
+            return (time - times_[key]) / (times_[key + 1] - times_[key]);
+        }
+
+        template <std::size_t N, typename T>
+        void TrackSet<N, T>::sample(Cursor& cursor, float time, Interpolation mode, std::span<vec_type> out) const
+        {
+            assert(out.size() == tracks_); //"[ERROR] One output per track"
+
+            const T s = static_cast<T>(locate(cursor, time));
+            const size_type k0 = cursor.key;
+            const size_type k1 = std::min(k0 + 1, key_count() - 1);
+
+            if (mode == Interpolation::Step || k0 == k1)
+                return blend<1>({ value_plane(s < T{ 1 } ? k0 : k1) }, { T{ 1 } }, out);
+
+            if (mode == Interpolation::Linear)
+                return blend<2>({ value_plane(k0), value_plane(k1) }, { T{ 1 } - s, s }, out);
+
+            // Cubic Hermite basis
+            const T s2  = s * s;
+            const T s3  = s2 * s;
+            const T h00 = T{ 2 } * s3 - T{ 3 } * s2 + T{ 1 };
+            const T h10 = s3 - T{ 2 } * s2 + s;
+            const T h01 = T{ 3 } * s2 - T{ 2 } * s3;
+            const T h11 = s3 - s2;
+            const T dt  = static_cast<T>(times_[k1] - times_[k0]);
+
+            if (mode == Interpolation::CubicHermite)
+                return blend<4>({ value_plane(k0), value_plane(k1), tangent_plane(k0), tangent_plane(k1) },
+                                { h00, h01, h10 * dt, h11 * dt }, out);
+
+            // Catmull-Rom: m0 = (p1 - p_) / (t1 - t_), m1 = (p2 - p0) / (t2 - t0), folded into the weights.
+            // At the ends the missing neighbour is the key itself, which gives a one-sided difference.
+            const size_type kp = (k0 > 0) ? k0 - 1 : k0;
+            const size_type kn = std::min(k1 + 1, key_count() - 1);
+
+            const T w0 = h10 * dt / static_cast<T>(times_[k1] - times_[kp]);
+            const T w1 = h11 * dt / static_cast<T>(times_[kn] - times_[k0]);
+
+            return blend<4>({ value_plane(kp), value_plane(k0), value_plane(k1), value_plane(kn) },
+                            { -w0, h00 - w1, h01 + w0, w1 }, out);
+        }
+
+        template <std::size_t N, typename T>
+            template <std::size_t Taps>
+        void TrackSet<N, T>::blend(const std::array<const T*, Taps>& planes, const std::array<T, Taps>& weights,
+                                   std::span<vec_type> out) const
+        {
+            const size_type tracks = tracks_;
+
+            for (size_type track{}; track < tracks; ++track)
+            {
+                vec_type& dst = out[track];
+
+                Vec::Kernels::for_each<N>([&](std::size_t comp)
+                {
+                    const size_type idx = comp * tracks + track;
+
+                    T acc = weights[0] * planes[0][idx];
+
+                    for (size_type tap{ 1 }; tap < Taps; ++tap)
+                        acc += weights[tap] * planes[tap][idx];
+
+                    dst[comp] = acc;
+                });
+            }
+        }
+
+        template <typename T>
+        void RotationSet<T>::add_key(float time, std::span<const quat_type> rotations, std::span<const quat_type> tangents)
+        {
+            assert(rotations.size() == track_count());                    //"[ERROR] One rotation per track"
+            assert(tangents.empty() || tangents.size() == track_count()); //"[ERROR] One tangent per track"
+
+            const size_type previous = key_count();
+
+            for (size_type track{}; track < track_count(); ++track)
+            {
+                scratch_[track] = rotations[track];
+                scratch_tangents_[track] = tangents.empty() ? quat_type{} : tangents[track];
+
+                if (previous == 0)
+                    continue;
+
+                const quat_type last = keys_.value(previous - 1, track);
+                const T side = Vec::Kernels::accumulate<4ULL, T>([&](std::size_t idx) { return scratch_[track][idx] * last[idx]; });
+
+                if (side < T{})
+                {
+                    scratch_[track].negative();
+                    scratch_tangents_[track].negative();
+                }
+            }
+
+            keys_.add_key(time, std::span<const quat_type>{ scratch_ }, std::span<const quat_type>{ scratch_tangents_ });
+        }
+
+        template <typename T>
+        void RotationSet<T>::sample(Cursor& cursor, float time, Interpolation mode, std::span<quat_type> out) const
+        {
+            keys_.sample(cursor, time, mode, out);
+
+            for (auto& rotation : out)
+                Vec::Kernels::normalize(rotation);
+        }
+    }
+}
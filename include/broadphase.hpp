@@ -0,0 +1,501 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <vector>
+#include <span>
+#include <numeric>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utils.hpp>
+#include <vec.hpp>
+#include <executor.hpp>
+
+namespace Pandora
+{
+    namespace Broadphase
+    {
+        template <std::size_t N, typename T>
+        struct AABB
+        {
+            static_assert(N == 2ULL || N == 3ULL, "[ERROR] AABB is only defined in R2 and R3");
+            static_assert(std::is_arithmetic_v<T>, "[ERROR] Type \"T\" need to be arithmetic");
+
+            Vec::vec<N, T> lower;
+            Vec::vec<N, T> upper;
+
+            constexpr inline bool overlaps(const AABB& obj) const
+            {
+                return Vec::Kernels::all_of<N>([&](std::size_t idx)
+                {
+                    return lower[idx] <= obj.upper[idx] && obj.lower[idx] <= upper[idx];
+                });
+            }
+
+            constexpr inline bool contains(const Vec::vec<N, T>& point) const
+            {
+                return Vec::Kernels::all_of<N>([&](std::size_t idx)
+                {
+                    return lower[idx] <= point[idx] && point[idx] <= upper[idx];
+                });
+            }
+
+            constexpr inline Vec::vec<N, T> center() const
+            {
+                Vec::vec<N, T> result;
+
+                Vec::Kernels::for_each<N>([&](std::size_t idx) { result[idx] = (lower[idx] + upper[idx]) / T{ 2 }; });
+
+                return result;
+            }
+        };
+
+        namespace FastDefs
+        {
+            using AABB2fp = AABB<2ULL, float>;
+            using AABB3fp = AABB<3ULL, float>;
+            using AABB2dp = AABB<2ULL, double>;
+            using AABB3dp = AABB<3ULL, double>;
+        }
+
+        // Indices into the box span given to update(), always first < second
+        struct Pair
+        {
+            std::uint32_t first;
+            std::uint32_t second;
+
+            friend constexpr bool operator== (const Pair&, const Pair&) = default;
+        };
+
+        // Concatenate the per-chunk results into out in chunk order, reusing its capacity
+        inline void gather_pairs(const std::vector<std::vector<Pair>>& buffers, std::size_t chunks, std::vector<Pair>& out)
+        {
+            std::size_t total{};
+
+            for (std::size_t chunk{}; chunk < chunks; ++chunk)
+                total += buffers[chunk].size();
+
+            out.clear();
+            out.reserve(total);
+
+            for (std::size_t chunk{}; chunk < chunks; ++chunk)
+                out.insert(out.end(), buffers[chunk].begin(), buffers[chunk].end());
+        }
+
+        // Sort-and-sweep along one axis.
+        // Bodies stay in the order of the previous frame and are re-sorted with an insertion
+        // sort, which is O(n + swaps) for the small motion between ticks. When too many bodies
+        // jump (teleports, respawns, recycled slots) the insertion sort is abandoned for a full
+        // O(n log n) sort. The axis with the widest spread of centers is used; switching axis
+        // (or body count) also triggers a full sort.
+        // update() runs on the calling thread, only find_pairs() is spread over the executor.
+        template <std::size_t N, typename T>
+        class SortAndSweep
+        {
+            public:
+                using box_type  = AABB<N, T>;
+                using size_type = std::size_t;
+
+            public:
+                SortAndSweep() = default;
+
+                void update(std::span<const box_type> boxes);
+
+                // Every overlapping pair of the last update()
+                void find_pairs(std::vector<Pair>& out, Parallel::Executor& executor = Parallel::default_executor());
+
+                constexpr size_type axis() const { return axis_; }
+
+            private:
+                static constexpr size_type sweep_block  = 64ULL;
+                static constexpr size_type shift_budget = 4ULL; // insertion sort shifts per body before falling back to a full sort
+
+                size_type select_axis(std::span<const box_type> boxes) const;
+
+            private:
+                size_type                       axis_{};
+                std::vector<std::uint32_t>      order_;   // body index per sorted slot
+                std::vector<T>                  keys_;    // lower bound on axis_ per sorted slot
+                std::array<std::vector<T>, N>   lower_;   // box bounds per axis, in sorted order
+                std::array<std::vector<T>, N>   upper_;
+                std::vector<std::vector<Pair>>  buffers_; // one per chunk, kept between frames
+        };
+
+        // Spatial hash over a uniform grid of cubic cells.
+        // Every body is entered in each cell its box touches, and a pair is only reported by the
+        // cell holding the lower corner of the two boxes' intersection, so no deduplication pass
+        // is needed. cell_size should be around the size of a typical body.
+        // The bucket table is resized by update() to keep about two buckets per entry, so the
+        // chains stay short as the scene grows; its storage is kept between frames.
+        // update() runs on the calling thread, only find_pairs() is spread over the executor.
+        template <std::size_t N, typename T>
+        class HashGrid
+        {
+            public:
+                using box_type  = AABB<N, T>;
+                using size_type = std::size_t;
+                using cell_type = std::array<std::int32_t, N>;
+
+            public:
+                explicit HashGrid(T cell_size)
+                    : cell_size_{ cell_size }
+                    , buckets_(2, 0)
+                {
+                    assert(cell_size > T{}); //"[ERROR] Cell size needs to be greater than zero"
+                }
+
+                void update(std::span<const box_type> boxes);
+
+                // Every overlapping pair of the last update()
+                void find_pairs(std::vector<Pair>& out, Parallel::Executor& executor = Parallel::default_executor());
+
+            private:
+                struct Entry
+                {
+                    cell_type     cell;
+                    std::uint32_t body;
+                };
+
+                cell_type cell_of(const Vec::vec<N, T>& point) const;
+                size_type bucket_of(const cell_type& cell) const;
+
+                template <typename F>
+                void for_each_cell(const box_type& box, F&& func) const;
+
+            private:
+                T                               cell_size_;
+                std::vector<size_type>          buckets_; // start of every bucket in entries_, plus the end (power of two buckets)
+                std::vector<Entry>              staging_;
+                std::vector<Entry>              entries_; // staging_ grouped by bucket
+                std::vector<box_type>           boxes_;
+                std::vector<std::vector<Pair>>  buffers_;
+        };
+
+        //////////////////////////////////////////// Sort and Sweep ///////////////////////////////////////////////////
+
+        template <std::size_t N, typename T>
+        typename SortAndSweep<N, T>::size_type SortAndSweep<N, T>::select_axis(std::span<const box_type> boxes) const
+        {
+            std::array<double, N> sum{};
+            std::array<double, N> sum_sq{};
+
+            for (const auto& box : boxes)
+            {
+                const auto center = box.center();
+
+                for (size_type idx{}; idx < N; ++idx)
+                {
+                    sum[idx]    += center[idx];
+                    sum_sq[idx] += POW2(static_cast<double>(center[idx]));
+                }
+            }
+
+            std::array<double, N> variance{};
+
+            for (size_type idx{}; idx < N; ++idx)
+                variance[idx] = sum_sq[idx] - POW2(sum[idx]) / static_cast<double>(boxes.size());
+
+            // Only move away from the current axis for a clear gain, a full sort is not free
+            constexpr double hysteresis = 1.25;
+
+            size_type best = axis_;
+
+            for (size_type idx{}; idx < N; ++idx)
+                if (variance[idx] > variance[best] * hysteresis)
+                    best = idx;
+
+            return best;
+        }
+
+        template <std::size_t N, typename T>
+        void SortAndSweep<N, T>::update(std::span<const box_type> boxes)
+        {
+            const size_type count = boxes.size();
+
+            if (count == 0)
+            {
+                order_.clear();
+                keys_.clear();
+                return;
+            }
+
+            const size_type axis = select_axis(boxes);
+            bool full_sort = (count != order_.size() || axis != axis_);
+
+            axis_ = axis;
+            keys_.resize(count);
+
+            if (!full_sort)
+            {
+                for (size_type slot{}; slot < count; ++slot)
+                    keys_[slot] = boxes[order_[slot]].lower[axis];
+
+                // Insertion sort over the previous order, given up once it stops being cheap
+                const size_type budget = shift_budget * count;
+                size_type shifts{};
+
+                for (size_type slot{ 1 }; slot < count && !full_sort; ++slot)
+                {
+                    const T key = keys_[slot];
+                    const std::uint32_t body = order_[slot];
+
+                    size_type hole = slot;
+
+                    for (; hole > 0 && key < keys_[hole - 1]; --hole)
+                    {
+                        keys_[hole]  = keys_[hole - 1];
+                        order_[hole] = order_[hole - 1];
+                    }
+
+                    keys_[hole]  = key;
+                    order_[hole] = body;
+
+                    shifts += slot - hole;
+                    full_sort = (shifts > budget);
+                }
+            }
+
+            if (full_sort)
+            {
+                order_.resize(count);
+                std::iota(order_.begin(), order_.end(), std::uint32_t{});
+                std::sort(order_.begin(), order_.end(), [&](std::uint32_t lhs, std::uint32_t rhs)
+                {
+                    return boxes[lhs].lower[axis] < boxes[rhs].lower[axis];
+                });
+
+                for (size_type slot{}; slot < count; ++slot)
+                    keys_[slot] = boxes[order_[slot]].lower[axis];
+            }
+
+            for (size_type idx{}; idx < N; ++idx)
+            {
+                lower_[idx].resize(count);
+                upper_[idx].resize(count);
+
+                for (size_type slot{}; slot < count; ++slot)
+                {
+                    lower_[idx][slot] = boxes[order_[slot]].lower[idx];
+                    upper_[idx][slot] = boxes[order_[slot]].upper[idx];
+                }
+            }
+        }
+
+        template <std::size_t N, typename T>
+        void SortAndSweep<N, T>::find_pairs(std::vector<Pair>& out, Parallel::Executor& executor)
+        {
+            const size_type count = order_.size();
+            const size_type chunks = Parallel::chunk_count(executor, count);
+
+            if (buffers_.size() < chunks)
+                buffers_.resize(chunks);
+
+            Parallel::for_each_chunk(executor, count, chunks, [&](size_type chunk, size_type begin, size_type end)
+            {
+                auto& pairs = buffers_[chunk];
+                pairs.clear();
+
+                // Raw views, so the pushes below cannot force the bounds to be reloaded
+                std::array<const T*, N> lower{};
+                std::array<const T*, N> upper{};
+
+                for (size_type idx{}; idx < N; ++idx)
+                {
+                    lower[idx] = lower_[idx].data();
+                    upper[idx] = upper_[idx].data();
+                }
+
+                const T* keys = keys_.data();
+                const std::uint32_t* order = order_.data();
+
+                for (size_type slot{ begin }; slot < end; ++slot)
+                {
+                    const size_type stop = static_cast<size_type>(
+                        std::upper_bound(keys + slot + 1, keys + count, upper[axis_][slot]) - keys);
+
+                    std::array<T, N> slot_lower{};
+                    std::array<T, N> slot_upper{};
+
+                    for (size_type idx{}; idx < N; ++idx)
+                    {
+                        slot_lower[idx] = lower[idx][slot];
+                        slot_upper[idx] = upper[idx][slot];
+                    }
+
+                    // Candidates already overlap on axis_. The other axes are tested a block at a
+                    // time into a flag buffer, a branch free loop the compiler can vectorize.
+                    for (size_type block{ slot + 1 }; block < stop; block += sweep_block)
+                    {
+                        const size_type width = std::min(sweep_block, stop - block);
+
+                        std::array<std::uint8_t, sweep_block> hits;
+
+                        for (size_type lane{}; lane < width; ++lane)
+                        {
+                            std::uint8_t hit{ 1 };
+
+                            for (size_type idx{}; idx < N; ++idx)
+                                hit &= static_cast<std::uint8_t>((slot_lower[idx] <= upper[idx][block + lane]) &
+                                                                 (lower[idx][block + lane] <= slot_upper[idx]));
+
+                            hits[lane] = hit;
+                        }
+
+                        for (size_type lane{}; lane < width; ++lane)
+                            if (hits[lane])
+                                pairs.push_back(Pair{ std::min(order[slot], order[block + lane]),
+                                                      std::max(order[slot], order[block + lane]) });
+                    }
+                }
+            });
+
+            gather_pairs(buffers_, chunks, out);
+        }
+
+        //////////////////////////////////////////// Hash Grid ////////////////////////////////////////////////////////
+
+        template <std::size_t N, typename T>
+        typename HashGrid<N, T>::cell_type HashGrid<N, T>::cell_of(const Vec::vec<N, T>& point) const
+        {
+            cell_type cell{};
+
+            for (size_type idx{}; idx < N; ++idx)
+                cell[idx] = static_cast<std::int32_t>(std::floor(point[idx] / cell_size_));
+
+            return cell;
+        }
+
+        template <std::size_t N, typename T>
+        typename HashGrid<N, T>::size_type HashGrid<N, T>::bucket_of(const cell_type& cell) const
+        {
+            constexpr std::array<std::uint32_t, 3> primes{ 73856093u, 19349663u, 83492791u };
+
+            std::uint32_t hash{};
+
+            for (size_type idx{}; idx < N; ++idx)
+                hash ^= static_cast<std::uint32_t>(cell[idx]) * primes[idx];
+
+            // The bucket is taken from the low bits, mix the high ones in first
+            hash ^= hash >> 16;
+            hash *= 0x7feb352du;
+            hash ^= hash >> 15;
+
+            return hash & (buckets_.size() - 2);
+        }
+
+        template <std::size_t N, typename T>
+            template <typename F>
+        void HashGrid<N, T>::for_each_cell(const box_type& box, F&& func) const
+        {
+            const cell_type first = cell_of(box.lower);
+            const cell_type last  = cell_of(box.upper);
+
+            cell_type cell = first;
+
+            while (true)
+            {
+                func(cell);
+
+                size_type idx{};
+
+                for (; idx < N; ++idx)
+                {
+                    if (cell[idx] < last[idx])
+                    {
+                        ++cell[idx];
+                        break;
+                    }
+
+                    cell[idx] = first[idx];
+                }
+
+                if (idx == N)
+                    return;
+            }
+        }
+
+        template <std::size_t N, typename T>
+        void HashGrid<N, T>::update(std::span<const box_type> boxes)
+        {
+            boxes_.assign(boxes.begin(), boxes.end());
+            staging_.clear();
+
+            for (size_type body{}; body < boxes_.size(); ++body)
+                for_each_cell(boxes_[body], [&](const cell_type& cell)
+                {
+                    staging_.push_back(Entry{ cell, static_cast<std::uint32_t>(body) });
+                });
+
+            // At least twice as many buckets as entries, rounded up to a power of two
+            size_type bucket_count{ 1 };
+
+            while (bucket_count < 2 * staging_.size())
+                bucket_count <<= 1;
+
+            // Counting sort of the entries by bucket
+            buckets_.assign(bucket_count + 1, size_type{});
+
+            for (const auto& entry : staging_)
+                ++buckets_[bucket_of(entry.cell) + 1];
+
+            std::partial_sum(buckets_.begin(), buckets_.end(), buckets_.begin());
+
+            entries_.resize(staging_.size());
+
+            for (const auto& entry : staging_)
+                entries_[buckets_[bucket_of(entry.cell)]++] = entry;
+
+            // The scatter advanced every start to the next bucket's start, shift them back
+            for (size_type bucket{ bucket_count }; bucket > 0; --bucket)
+                buckets_[bucket] = buckets_[bucket - 1];
+
+            buckets_[0] = 0;
+        }
+
+        template <std::size_t N, typename T>
+        void HashGrid<N, T>::find_pairs(std::vector<Pair>& out, Parallel::Executor& executor)
+        {
+            const size_type bucket_count = buckets_.size() - 1;
+            const size_type chunks = Parallel::chunk_count(executor, bucket_count);
+
+            if (buffers_.size() < chunks)
+                buffers_.resize(chunks);
+
+            Parallel::for_each_chunk(executor, bucket_count, chunks, [&](size_type chunk, size_type begin, size_type end)
+            {
+                auto& pairs = buffers_[chunk];
+                pairs.clear();
+
+                for (size_type bucket{ begin }; bucket < end; ++bucket)
+                    for (size_type lhs{ buckets_[bucket] }; lhs < buckets_[bucket + 1]; ++lhs)
+                        for (size_type rhs{ lhs + 1 }; rhs < buckets_[bucket + 1]; ++rhs)
+                        {
+                            const Entry& a = entries_[lhs];
+                            const Entry& b = entries_[rhs];
+
+                            // Distinct cells can share a bucket
+                            if (a.cell != b.cell)
+                                continue;
+
+                            const box_type& box_a = boxes_[a.body];
+                            const box_type& box_b = boxes_[b.body];
+
+                            if (!box_a.overlaps(box_b))
+                                continue;
+
+                            Vec::vec<N, T> corner;
+
+                            for (size_type idx{}; idx < N; ++idx)
+                                corner[idx] = std::max(box_a.lower[idx], box_b.lower[idx]);
+
+                            if (cell_of(corner) == a.cell)
+                                pairs.push_back(Pair{ std::min(a.body, b.body), std::max(a.body, b.body) });
+                        }
+            });
+
+            gather_pairs(buffers_, chunks, out);
+        }
+    }
+}
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utils.hpp>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace Pandora
+{
+    namespace Parallel
+    {
+        // A half-open index range and the function to run over it.
+        // Ranges larger than grain are split in two on execution, the upper half becomes a new task.
+        struct Task
+        {
+            void (*invoke)(const void*, std::size_t, std::size_t);
+            const void*               context;
+            std::size_t               begin;
+            std::size_t               end;
+            std::size_t               grain;
+            std::atomic<std::size_t>* pending;
+        };
+
+        struct Options
+        {
+            bool spawn_threads = true;  // false: the caller's own threads enter through run() and are joined by the caller before ~Executor
+            bool pin_threads   = false; // bind worker i to the i-th CPU of the affinity mask (Linux only, ignored elsewhere)
+        };
+
+        // Work-stealing executor.
+        // Every worker owns a deque: it pushes and pops at the back, idle workers steal from the
+        // front of the others. Threads that are not workers (e.g. the one calling parallel_for)
+        // queue into one extra shared deque and help run tasks until their own work is finished,
+        // so concurrency() == workers + 1 and an executor with zero workers still runs everything.
+        // The deques are fixed-size rings allocated with the executor, so running tasks never
+        // allocates; when a ring is full the task stops splitting and runs the rest of its range.
+        //
+        // Tasks must not throw.
+        class Executor
+        {
+            public:
+                using size_type = std::size_t;
+
+            public:
+
+                //////////////////////////////////////////// Constructors /////////////////////////////////////////////
+
+                explicit Executor(size_type workers = Utils::default_threads() - 1u, Options options = {})
+                    : options_{ options }
+                    , queues_(workers + 1)
+                {
+                    if (options_.spawn_threads)
+                    {
+                        threads_.reserve(workers);
+
+                        for (size_type slot{}; slot < workers; ++slot)
+                            threads_.emplace_back([this, slot] { run(slot); });
+                    }
+                }
+
+                Executor(const Executor&) = delete;
+                Executor& operator= (const Executor&) = delete;
+
+                ~Executor()
+                {
+                    stop();
+
+                    for (auto& thread : threads_)
+                        thread.join();
+                }
+
+                //////////////////////////////////////// Functions in Class ///////////////////////////////////////////
+
+                constexpr size_type workers()     const { return queues_.size() - 1; }
+                constexpr size_type concurrency() const { return queues_.size(); }
+
+                // Worker loop for slot in [0, workers()). Called by the executor's own threads, or
+                // by caller-owned threads when Options::spawn_threads is false. Returns after stop().
+                // Caller-owned threads must have returned from run() (joined) before ~Executor.
+                inline void run(size_type slot);
+
+                // Ask every worker to leave run(). Workers return as soon as they see the request,
+                // without draining the queues; tasks still queued are run by the threads waiting on them.
+                inline void stop();
+
+                // Execute task on the calling thread, splitting it down to its grain
+                inline void execute(Task task);
+
+                // Run queued tasks until pending drops to zero
+                inline void wait(const std::atomic<size_type>& pending);
+
+            private:
+                static constexpr size_type queue_capacity = 1024; // power of two
+
+                struct Queue
+                {
+                    std::mutex                       mutex;
+                    std::array<Task, queue_capacity> tasks;
+                    size_type                        head{}; // front, where thieves take from
+                    size_type                        tail{}; // one past the back, where the owner works
+                };
+
+                inline size_type current_slot() const;
+                inline bool push(size_type slot, const Task& task);
+                inline bool pop(size_type slot, Task& task);
+                inline bool steal(size_type slot, Task& task);
+                inline void pin(size_type slot) const;
+
+            private:
+                Options                               options_;
+                std::vector<Queue>                    queues_; // one per worker, the last is shared
+                std::vector<std::thread>              threads_;
+                std::atomic<size_type>                queued_{};
+                std::atomic<unsigned>                 sleepers_{};
+                std::atomic<bool>                     stopping_{};
+                std::mutex                            sleep_mutex_;
+                std::condition_variable               sleep_cv_;
+
+                // Slot of the calling thread within the executor it is working for
+                struct Binding
+                {
+                    const Executor* owner;
+                    size_type       slot;
+                };
+
+                static inline thread_local Binding binding_{ nullptr, 0 };
+        };
+
+        // Shared executor for calls that do not pass their own
+        inline Executor& default_executor()
+        {
+            static Executor executor{};
+
+            return executor;
+        }
+
+        //////////////////////////////////////////// Member Functions /////////////////////////////////////////////////
+
+        inline Executor::size_type Executor::current_slot() const
+        {
+            return (binding_.owner == this) ? binding_.slot : workers();
+        }
+
+        inline bool Executor::push(size_type slot, const Task& task)
+        {
+            Queue& queue = queues_[slot];
+
+            {
+                std::lock_guard lock{ queue.mutex };
+
+                if (queue.tail - queue.head == queue_capacity)
+                    return false;
+
+                queue.tasks[queue.tail++ % queue_capacity] = task;
+            }
+
+            queued_.fetch_add(1);
+
+            if (sleepers_.load() > 0)
+            {
+                std::lock_guard lock{ sleep_mutex_ };
+                sleep_cv_.notify_one();
+            }
+
+            return true;
+        }
+
+        inline bool Executor::pop(size_type slot, Task& task)
+        {
+            Queue& queue = queues_[slot];
+
+            std::lock_guard lock{ queue.mutex };
+
+            if (queue.head == queue.tail)
+                return false;
+
+            task = queue.tasks[--queue.tail % queue_capacity];
+            queued_.fetch_sub(1);
+
+            return true;
+        }
+
+        inline bool Executor::steal(size_type slot, Task& task)
+        {
+            const size_type count = queues_.size();
+
+            for (size_type offset{ 1 }; offset < count; ++offset)
+            {
+                Queue& victim = queues_[(slot + offset) % count];
+
+                std::unique_lock lock{ victim.mutex, std::try_to_lock };
+
+                if (!lock.owns_lock() || victim.head == victim.tail)
+                    continue;
+
+                task = victim.tasks[victim.head++ % queue_capacity];
+                queued_.fetch_sub(1);
+
+                return true;
+            }
+
+            return false;
+        }
+
+        inline void Executor::pin([[maybe_unused]] size_type slot) const
+        {
+            if (!options_.pin_threads)
+                return;
+
+#if defined(__linux__)
+            // Slot i goes to the i-th CPU the thread may run on, so cpusets and taskset are respected
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+
+            [[maybe_unused]] const int queried = sched_getaffinity(0, sizeof(allowed), &allowed);
+            assert(queried == 0); //"[ERROR] Could not read the CPU affinity mask"
+
+            const int count = CPU_COUNT(&allowed);
+
+            if (count == 0)
+                return;
+
+            int target = static_cast<int>(slot % static_cast<size_type>(count));
+            int cpu{};
+
+            for (; cpu < CPU_SETSIZE; ++cpu)
+                if (CPU_ISSET(cpu, &allowed) && target-- == 0)
+                    break;
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+
+            [[maybe_unused]] const int pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            assert(pinned == 0); //"[ERROR] Could not pin the worker thread"
+#endif
+        }
+
+        inline void Executor::run(size_type slot)
+        {
+            assert(slot < workers()); //"[ERROR] Invalid worker slot"
+
+            binding_ = Binding{ this, slot };
+            pin(slot);
+
+            constexpr unsigned spins = 64u;
+
+            while (!stopping_.load())
+            {
+                Task task;
+                bool found = false;
+
+                for (unsigned spin{}; spin < spins && !found; ++spin)
+                {
+                    found = pop(slot, task) || steal(slot, task);
+
+                    if (!found)
+                        std::this_thread::yield();
+                }
+
+                if (found)
+                {
+                    execute(task);
+                    continue;
+                }
+
+                std::unique_lock lock{ sleep_mutex_ };
+
+                sleepers_.fetch_add(1);
+                sleep_cv_.wait(lock, [this] { return queued_.load() > 0 || stopping_.load(); });
+                sleepers_.fetch_sub(1);
+            }
+
+            binding_ = Binding{ nullptr, 0 };
+        }
+
+        inline void Executor::stop()
+        {
+            std::lock_guard lock{ sleep_mutex_ };
+
+            stopping_.store(true);
+            sleep_cv_.notify_all();
+        }
+
+        inline void Executor::execute(Task task)
+        {
+            const size_type slot = current_slot();
+
+            while (task.end - task.begin > task.grain)
+            {
+                const size_type middle = task.begin + (task.end - task.begin) / 2;
+
+                Task upper = task;
+                upper.begin = middle;
+
+                task.pending->fetch_add(1);
+
+                // Queue full: keep the whole range on this thread
+                if (!push(slot, upper))
+                {
+                    task.pending->fetch_sub(1);
+                    break;
+                }
+
+                task.end = middle;
+            }
+
+            task.invoke(task.context, task.begin, task.end);
+            task.pending->fetch_sub(1);
+        }
+
+        inline void Executor::wait(const std::atomic<size_type>& pending)
+        {
+            const size_type slot = current_slot();
+
+            while (pending.load() != 0)
+            {
+                Task task;
+
+                if (pop(slot, task) || steal(slot, task))
+                    execute(task);
+                else
+                    std::this_thread::yield();
+            }
+        }
+
+        //////////////////////////////////////////// Algorithms ///////////////////////////////////////////////////////
+
+        // func(begin, end) over sub-ranges of [begin, end) no larger than grain
+        template <typename F>
+        inline void parallel_for(Executor& executor, std::size_t begin, std::size_t end, std::size_t grain, F&& func)
+        {
+            if (begin >= end)
+                return;
+
+            using func_type = std::remove_reference_t<F>;
+
+            std::atomic<std::size_t> pending{ 1 };
+
+            executor.execute(Task{
+                [](const void* context, std::size_t first, std::size_t last)
+                {
+                    (*static_cast<func_type*>(const_cast<void*>(context)))(first, last);
+                },
+                static_cast<const void*>(&func), begin, end, std::max<std::size_t>(grain, 1), &pending });
+
+            executor.wait(pending);
+        }
+
+        // Default split of count items: a few chunks per thread, so stealing can even out the load
+        inline std::size_t chunk_count(const Executor& executor, std::size_t count)
+        {
+            constexpr std::size_t chunks_per_thread = 8;
+
+            return std::min(count, executor.concurrency() * chunks_per_thread);
+        }
+
+        // func(chunk, begin, end) for chunks fixed contiguous slices of [0, count).
+        // Slices only depend on count and chunks, so per-chunk results can be combined in order.
+        template <typename F>
+        inline void for_each_chunk(Executor& executor, std::size_t count, std::size_t chunks, F&& func)
+        {
+            parallel_for(executor, 0, chunks, 1, [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t chunk{ first }; chunk < last; ++chunk)
+                    func(chunk, chunk * count / chunks, (chunk + 1) * count / chunks);
+            });
+        }
+
+        // Most slices parallel_reduce() splits a range into, its partial results live on the stack
+        constexpr inline std::size_t max_reduce_chunks = 256ULL;
+
+        // Stack given to the partial results, larger R get fewer slices
+        constexpr inline std::size_t max_reduce_bytes = 16384ULL;
+
+        template <typename R>
+        constexpr inline std::size_t reduce_chunks_v = std::clamp<std::size_t>(max_reduce_bytes / sizeof(R), 1ULL, max_reduce_chunks);
+
+        // combine(identity, map(b0, e0), map(b1, e1), ...) over fixed slices of [begin, end),
+        // folded in index order. The slices depend only on the range, grain and R, never on the
+        // executor, so the result is the same on every machine. R must be default constructible.
+        template <typename R, typename Map, typename Combine>
+        inline R parallel_reduce(Executor& executor, std::size_t begin, std::size_t end, std::size_t grain,
+                                 R identity, Map&& map, Combine&& combine)
+        {
+            if (begin >= end)
+                return identity;
+
+            const std::size_t count  = end - begin;
+            const std::size_t slice  = std::max<std::size_t>(grain, 1);
+            const std::size_t chunks = std::min((count + slice - 1) / slice, reduce_chunks_v<R>);
+
+            std::array<R, reduce_chunks_v<R>> partial;
+
+            for_each_chunk(executor, count, chunks, [&](std::size_t chunk, std::size_t first, std::size_t last)
+            {
+                partial[chunk] = map(begin + first, begin + last);
+            });
+
+            R result = identity;
+
+            for (std::size_t chunk{}; chunk < chunks; ++chunk)
+                result = combine(result, partial[chunk]);
+
+            return result;
+        }
+    }
+}
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <type_traits>
 #include <array>
+#include <cassert>
 namespace Pandora::Mat
 {
 	//Mat<row, column, type>
@@ -87,6 +88,10 @@ namespace Pandora::Mat
 			void identity();
 			void transpose();
 
+			// Element at (row, column), storage is row-major
+			constexpr inline T& operator() (uint8_t row, uint8_t col);
+			constexpr inline const T& operator() (uint8_t row, uint8_t col) const;
+
 		private:
 			std::array<T, R * C> mat_;
 	};
@@ -99,6 +104,22 @@ namespace Pandora::Mat
 		mat_.fill(std::forward<U>(init_value));
 	}
 
+	template <uint8_t R, uint8_t C, typename T>
+	constexpr inline T& Mat<R, C, T>::operator() (uint8_t row, uint8_t col)
+	{
+		assert(row < R && col < C); //"[ERROR] Invalid index");
+
+		return mat_[row * C + col];
+	}
+
+	template <uint8_t R, uint8_t C, typename T>
+	constexpr inline const T& Mat<R, C, T>::operator() (uint8_t row, uint8_t col) const
+	{
+		assert(row < R && col < C); //"[ERROR] Invalid index");
+
+		return mat_[row * C + col];
+	}
+
 	template <std::uint8_t R, std::uint8_t C, typename U>
     inline std::ostream& operator << (std::ostream& os, const Mat<R, C, U>& obj)
 	{
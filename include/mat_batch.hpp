@@ -0,0 +1,406 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utils.hpp>
+#include <vec.hpp>
+#include <mat.hpp>
+#include <executor.hpp>
+
+namespace Pandora::Mat
+{
+	// Interleaved (AoSoA) batch of Mat<R, C, T>.
+	// Matrices are grouped in blocks of W, and inside a block entry (i, j) of all W matrices is
+	// contiguous. The bulk operations below work on whole blocks with one matrix per lane, so
+	// every arithmetic step is a straight loop over W values however small the matrix is.
+	// Pick W as a multiple of the SIMD width for T (8 floats for AVX, 16 for AVX-512).
+	//
+	// Lanes past size() in the last block are processed like the others but never read back;
+	// resize() zeroes them before they come back into range, as std::vector would.
+	template <uint8_t R, uint8_t C, typename T, std::size_t W = 8>
+	class MatBatch
+	{
+		static_assert(std::is_arithmetic_v<T>, "[ERROR] Type \"T\" need to be arithmetic");
+		static_assert(W > 0, "[ERROR] The lane number needs to be greater than zero");
+
+		public:
+			using value_type = T;
+			using size_type  = std::size_t;
+			using mat_type   = Mat<R, C, T>;
+
+			static constexpr size_type lanes      = W;
+			static constexpr size_type block_size = static_cast<size_type>(R) * C * W;
+
+		public:
+			MatBatch() = default;
+
+			explicit MatBatch(size_type count)
+			{
+				resize(count);
+			}
+
+			constexpr size_type size()        const { return size_; }
+			constexpr size_type block_count() const { return blocks_.size(); }
+
+			void resize(size_type count)
+			{
+				// Lanes coming back into range may hold old matrices or padding results, clear them
+				if (count > size_ && size_ % W != 0)
+				{
+					T* data = blocks_[size_ / W].data.data();
+
+					for (size_type slot{}; slot < block_size; slot += W)
+						std::fill(data + slot + size_ % W, data + slot + W, T{});
+				}
+
+				blocks_.resize((count + W - 1) / W, Block{});
+				size_ = count;
+			}
+
+			void reserve(size_type count) { blocks_.reserve((count + W - 1) / W); }
+			void clear() { resize(0); }
+
+			void push_back(const mat_type& obj)
+			{
+				resize(size_ + 1);
+				set(size_ - 1, obj);
+			}
+
+			mat_type get(size_type index) const;
+			void set(size_type index, const mat_type& obj);
+
+			// The W lanes of entry (row, col) in block
+			constexpr T* entry(size_type block, uint8_t row, uint8_t col)
+			{
+				return blocks_[block].data.data() + (static_cast<size_type>(row) * C + col) * W;
+			}
+
+			constexpr const T* entry(size_type block, uint8_t row, uint8_t col) const
+			{
+				return blocks_[block].data.data() + (static_cast<size_type>(row) * C + col) * W;
+			}
+
+		private:
+			struct alignas(64) Block
+			{
+				std::array<T, block_size> data{};
+			};
+
+			std::vector<Block> blocks_;
+			size_type          size_{};
+	};
+
+	namespace FastDef
+	{
+		using Mat3x3fBatch = MatBatch<3, 3, float>;
+		using Mat4x4fBatch = MatBatch<4, 4, float>;
+		using Mat3x3dfBatch = MatBatch<3, 3, double>;
+		using Mat4x4dfBatch = MatBatch<4, 4, double>;
+	}
+
+	// Blocks handed to one task
+	constexpr inline std::size_t batch_grain = 64ULL;
+
+	template <uint8_t R, uint8_t C, typename T, std::size_t W>
+	typename MatBatch<R, C, T, W>::mat_type MatBatch<R, C, T, W>::get(size_type index) const
+	{
+		assert(index < size_); //"[ERROR] Invalid index");
+
+		mat_type result;
+
+		for (uint8_t row{}; row < R; ++row)
+			for (uint8_t col{}; col < C; ++col)
+				result(row, col) = entry(index / W, row, col)[index % W];
+
+		return result;
+	}
+
+	template <uint8_t R, uint8_t C, typename T, std::size_t W>
+	void MatBatch<R, C, T, W>::set(size_type index, const mat_type& obj)
+	{
+		assert(index < size_); //"[ERROR] Invalid index");
+
+		for (uint8_t row{}; row < R; ++row)
+			for (uint8_t col{}; col < C; ++col)
+				entry(index / W, row, col)[index % W] = obj(row, col);
+	}
+
+	// out[n] = lhs[n] * rhs[n], out must not be one of the inputs
+	template <uint8_t R, uint8_t K, uint8_t C, typename T, std::size_t W>
+	void multiply(const MatBatch<R, K, T, W>& lhs, const MatBatch<K, C, T, W>& rhs, MatBatch<R, C, T, W>& out,
+				  Parallel::Executor& executor = Parallel::default_executor())
+	{
+		assert(lhs.size() == rhs.size()); //"[ERROR] Batches of different size");
+		assert(static_cast<const void*>(&out) != &lhs && static_cast<const void*>(&out) != &rhs); //"[ERROR] Multiply can't run in place");
+
+		out.resize(lhs.size());
+
+		Parallel::parallel_for(executor, 0, lhs.block_count(), batch_grain, [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t block{ begin }; block < end; ++block)
+				for (uint8_t row{}; row < R; ++row)
+					for (uint8_t col{}; col < C; ++col)
+					{
+						std::array<T, W> acc{};
+
+						for (uint8_t inner{}; inner < K; ++inner)
+						{
+							const T* a = lhs.entry(block, row, inner);
+							const T* b = rhs.entry(block, inner, col);
+
+							for (std::size_t lane{}; lane < W; ++lane)
+								acc[lane] += a[lane] * b[lane];
+						}
+
+						std::copy(acc.begin(), acc.end(), out.entry(block, row, col));
+					}
+		});
+	}
+
+	// out[n] = lhs[n] * rhs[n] for vectors stored one per matrix.
+	// The spans are not deduced (vec sizes are std::size_t), so vectors of vec convert directly.
+	template <uint8_t R, uint8_t C, typename T, std::size_t W>
+	void multiply(const MatBatch<R, C, T, W>& lhs,
+				  std::type_identity_t<std::span<const Vec::vec<C, T>>> rhs,
+				  std::type_identity_t<std::span<Vec::vec<R, T>>> out,
+				  Parallel::Executor& executor = Parallel::default_executor())
+	{
+		assert(rhs.size() == lhs.size() && out.size() == lhs.size()); //"[ERROR] Batches of different size");
+
+		Parallel::parallel_for(executor, 0, lhs.block_count(), batch_grain, [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t block{ begin }; block < end; ++block)
+			{
+				const std::size_t base  = block * W;
+				const std::size_t count = std::min(W, lhs.size() - base);
+
+				// Transpose the vectors of this block into lanes
+				std::array<std::array<T, W>, C> vec_lanes{};
+
+				for (std::size_t lane{}; lane < count; ++lane)
+					for (uint8_t col{}; col < C; ++col)
+						vec_lanes[col][lane] = rhs[base + lane][col];
+
+				std::array<std::array<T, W>, R> result{};
+
+				for (uint8_t row{}; row < R; ++row)
+					for (uint8_t col{}; col < C; ++col)
+					{
+						const T* a = lhs.entry(block, row, col);
+
+						for (std::size_t lane{}; lane < W; ++lane)
+							result[row][lane] += a[lane] * vec_lanes[col][lane];
+					}
+
+				for (std::size_t lane{}; lane < count; ++lane)
+					for (uint8_t row{}; row < R; ++row)
+						out[base + lane][row] = result[row][lane];
+			}
+		});
+	}
+
+	// out must not be in
+	template <uint8_t R, uint8_t C, typename T, std::size_t W>
+	void transpose(const MatBatch<R, C, T, W>& in, MatBatch<C, R, T, W>& out,
+				   Parallel::Executor& executor = Parallel::default_executor())
+	{
+		assert(static_cast<const void*>(&in) != &out); //"[ERROR] Transpose can't run in place");
+
+		out.resize(in.size());
+
+		Parallel::parallel_for(executor, 0, in.block_count(), batch_grain, [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t block{ begin }; block < end; ++block)
+				for (uint8_t row{}; row < R; ++row)
+					for (uint8_t col{}; col < C; ++col)
+						std::copy_n(in.entry(block, row, col), W, out.entry(block, col, row));
+		});
+	}
+
+	// Determinant of every lane in one block and, when inv is given, the inverse (adjugate / det),
+	// for N = 2, 3, 4. The inverse is built in a local block and copied out in one go, so the lane
+	// loops never store through pointers that may alias the input and vectorize as written.
+	template <uint8_t N, typename T, std::size_t W>
+	inline void block_inverse(const MatBatch<N, N, T, W>& in, std::size_t block, std::array<T, W>& det,
+							  MatBatch<N, N, T, W>* inv)
+	{
+		static_assert(N >= 2 && N <= 4, "[ERROR] Determinant and inverse are only defined up to 4x4");
+
+		auto a = [&](uint8_t row, uint8_t col) { return in.entry(block, row, col); };
+
+		std::array<T, MatBatch<N, N, T, W>::block_size> result;
+
+		auto r = [&](uint8_t row, uint8_t col) { return result.data() + (static_cast<std::size_t>(row) * N + col) * W; };
+
+		if constexpr (N == 2)
+		{
+			const T *a00 = a(0, 0), *a01 = a(0, 1), *a10 = a(1, 0), *a11 = a(1, 1);
+
+			for (std::size_t lane{}; lane < W; ++lane)
+				det[lane] = a00[lane] * a11[lane] - a01[lane] * a10[lane];
+
+			if (inv == nullptr)
+				return;
+
+			T *r00 = r(0, 0), *r01 = r(0, 1), *r10 = r(1, 0), *r11 = r(1, 1);
+
+			for (std::size_t lane{}; lane < W; ++lane)
+			{
+				const T scale = T{ 1 } / det[lane];
+
+				r00[lane] =  a11[lane] * scale;
+				r01[lane] = -a01[lane] * scale;
+				r10[lane] = -a10[lane] * scale;
+				r11[lane] =  a00[lane] * scale;
+			}
+		}
+		else if constexpr (N == 3)
+		{
+			const T *a00 = a(0, 0), *a01 = a(0, 1), *a02 = a(0, 2);
+			const T *a10 = a(1, 0), *a11 = a(1, 1), *a12 = a(1, 2);
+			const T *a20 = a(2, 0), *a21 = a(2, 1), *a22 = a(2, 2);
+
+			std::array<T, W> c00, c01, c02;
+
+			for (std::size_t lane{}; lane < W; ++lane)
+			{
+				c00[lane] = a11[lane] * a22[lane] - a12[lane] * a21[lane];
+				c01[lane] = a12[lane] * a20[lane] - a10[lane] * a22[lane];
+				c02[lane] = a10[lane] * a21[lane] - a11[lane] * a20[lane];
+
+				det[lane] = a00[lane] * c00[lane] + a01[lane] * c01[lane] + a02[lane] * c02[lane];
+			}
+
+			if (inv == nullptr)
+				return;
+
+			T *r00 = r(0, 0), *r01 = r(0, 1), *r02 = r(0, 2);
+			T *r10 = r(1, 0), *r11 = r(1, 1), *r12 = r(1, 2);
+			T *r20 = r(2, 0), *r21 = r(2, 1), *r22 = r(2, 2);
+
+			for (std::size_t lane{}; lane < W; ++lane)
+			{
+				const T scale = T{ 1 } / det[lane];
+
+				r00[lane] = c00[lane] * scale;
+				r01[lane] = (a02[lane] * a21[lane] - a01[lane] * a22[lane]) * scale;
+				r02[lane] = (a01[lane] * a12[lane] - a02[lane] * a11[lane]) * scale;
+				r10[lane] = c01[lane] * scale;
+				r11[lane] = (a00[lane] * a22[lane] - a02[lane] * a20[lane]) * scale;
+				r12[lane] = (a02[lane] * a10[lane] - a00[lane] * a12[lane]) * scale;
+				r20[lane] = c02[lane] * scale;
+				r21[lane] = (a01[lane] * a20[lane] - a00[lane] * a21[lane]) * scale;
+				r22[lane] = (a00[lane] * a11[lane] - a01[lane] * a10[lane]) * scale;
+			}
+		}
+		else
+		{
+			const T *a00 = a(0, 0), *a01 = a(0, 1), *a02 = a(0, 2), *a03 = a(0, 3);
+			const T *a10 = a(1, 0), *a11 = a(1, 1), *a12 = a(1, 2), *a13 = a(1, 3);
+			const T *a20 = a(2, 0), *a21 = a(2, 1), *a22 = a(2, 2), *a23 = a(2, 3);
+			const T *a30 = a(3, 0), *a31 = a(3, 1), *a32 = a(3, 2), *a33 = a(3, 3);
+
+			// 2x2 minors of the top (s) and bottom (c) row pairs
+			std::array<T, W> s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5;
+
+			for (std::size_t lane{}; lane < W; ++lane)
+			{
+				s0[lane] = a00[lane] * a11[lane] - a10[lane] * a01[lane];
+				s1[lane] = a00[lane] * a12[lane] - a10[lane] * a02[lane];
+				s2[lane] = a00[lane] * a13[lane] - a10[lane] * a03[lane];
+				s3[lane] = a01[lane] * a12[lane] - a11[lane] * a02[lane];
+				s4[lane] = a01[lane] * a13[lane] - a11[lane] * a03[lane];
+				s5[lane] = a02[lane] * a13[lane] - a12[lane] * a03[lane];
+
+				c5[lane] = a22[lane] * a33[lane] - a32[lane] * a23[lane];
+				c4[lane] = a21[lane] * a33[lane] - a31[lane] * a23[lane];
+				c3[lane] = a21[lane] * a32[lane] - a31[lane] * a22[lane];
+				c2[lane] = a20[lane] * a33[lane] - a30[lane] * a23[lane];
+				c1[lane] = a20[lane] * a32[lane] - a30[lane] * a22[lane];
+				c0[lane] = a20[lane] * a31[lane] - a30[lane] * a21[lane];
+
+				det[lane] = s0[lane] * c5[lane] - s1[lane] * c4[lane] + s2[lane] * c3[lane]
+						  + s3[lane] * c2[lane] - s4[lane] * c1[lane] + s5[lane] * c0[lane];
+			}
+
+			if (inv == nullptr)
+				return;
+
+			T *r00 = r(0, 0), *r01 = r(0, 1), *r02 = r(0, 2), *r03 = r(0, 3);
+			T *r10 = r(1, 0), *r11 = r(1, 1), *r12 = r(1, 2), *r13 = r(1, 3);
+			T *r20 = r(2, 0), *r21 = r(2, 1), *r22 = r(2, 2), *r23 = r(2, 3);
+			T *r30 = r(3, 0), *r31 = r(3, 1), *r32 = r(3, 2), *r33 = r(3, 3);
+
+			for (std::size_t lane{}; lane < W; ++lane)
+			{
+				const T scale = T{ 1 } / det[lane];
+
+				r00[lane] = ( a11[lane] * c5[lane] - a12[lane] * c4[lane] + a13[lane] * c3[lane]) * scale;
+				r01[lane] = (-a01[lane] * c5[lane] + a02[lane] * c4[lane] - a03[lane] * c3[lane]) * scale;
+				r02[lane] = ( a31[lane] * s5[lane] - a32[lane] * s4[lane] + a33[lane] * s3[lane]) * scale;
+				r03[lane] = (-a21[lane] * s5[lane] + a22[lane] * s4[lane] - a23[lane] * s3[lane]) * scale;
+
+				r10[lane] = (-a10[lane] * c5[lane] + a12[lane] * c2[lane] - a13[lane] * c1[lane]) * scale;
+				r11[lane] = ( a00[lane] * c5[lane] - a02[lane] * c2[lane] + a03[lane] * c1[lane]) * scale;
+				r12[lane] = (-a30[lane] * s5[lane] + a32[lane] * s2[lane] - a33[lane] * s1[lane]) * scale;
+				r13[lane] = ( a20[lane] * s5[lane] - a22[lane] * s2[lane] + a23[lane] * s1[lane]) * scale;
+
+				r20[lane] = ( a10[lane] * c4[lane] - a11[lane] * c2[lane] + a13[lane] * c0[lane]) * scale;
+				r21[lane] = (-a00[lane] * c4[lane] + a01[lane] * c2[lane] - a03[lane] * c0[lane]) * scale;
+				r22[lane] = ( a30[lane] * s4[lane] - a31[lane] * s2[lane] + a33[lane] * s0[lane]) * scale;
+				r23[lane] = (-a20[lane] * s4[lane] + a21[lane] * s2[lane] - a23[lane] * s0[lane]) * scale;
+
+				r30[lane] = (-a10[lane] * c3[lane] + a11[lane] * c1[lane] - a12[lane] * c0[lane]) * scale;
+				r31[lane] = ( a00[lane] * c3[lane] - a01[lane] * c1[lane] + a02[lane] * c0[lane]) * scale;
+				r32[lane] = (-a30[lane] * s3[lane] + a31[lane] * s1[lane] - a32[lane] * s0[lane]) * scale;
+				r33[lane] = ( a20[lane] * s3[lane] - a21[lane] * s1[lane] + a22[lane] * s0[lane]) * scale;
+			}
+		}
+
+		std::copy(result.begin(), result.end(), inv->entry(block, 0, 0));
+	}
+
+	template <uint8_t N, typename T, std::size_t W>
+	void determinant(const MatBatch<N, N, T, W>& in, std::type_identity_t<std::span<T>> out,
+					 Parallel::Executor& executor = Parallel::default_executor())
+	{
+		assert(out.size() == in.size()); //"[ERROR] One output per matrix");
+
+		Parallel::parallel_for(executor, 0, in.block_count(), batch_grain, [&](std::size_t begin, std::size_t end)
+		{
+			std::array<T, W> det;
+
+			for (std::size_t block{ begin }; block < end; ++block)
+			{
+				block_inverse<N, T, W>(in, block, det, nullptr);
+
+				const std::size_t base = block * W;
+
+				std::copy_n(det.begin(), std::min(W, in.size() - base), out.begin() + base);
+			}
+		});
+	}
+
+	// Inverse through the adjugate; singular matrices give non-finite entries.
+	// in and out may be the same batch, every block is read fully before it is written.
+	template <uint8_t N, typename T, std::size_t W>
+	void inverse(const MatBatch<N, N, T, W>& in, MatBatch<N, N, T, W>& out,
+				 Parallel::Executor& executor = Parallel::default_executor())
+	{
+		static_assert(Utils::is_fp_v<T>, "[ERROR] Type \"T\" need a floating point");
+		out.resize(in.size());
+
+		Parallel::parallel_for(executor, 0, in.block_count(), batch_grain, [&](std::size_t begin, std::size_t end)
+		{
+			std::array<T, W> det;
+
+			for (std::size_t block{ begin }; block < end; ++block)
+				block_inverse<N, T, W>(in, block, det, &out);
+		});
+	}
+}
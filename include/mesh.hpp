@@ -0,0 +1,422 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <vector>
+#include <span>
+#include <numeric>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utils.hpp>
+#include <vec.hpp>
+#include <executor.hpp>
+
+namespace Pandora
+{
+    namespace Mesh
+    {
+        // Bulk kernels over an indexed triangle list: positions are vec<3, T> and every three
+        // entries of the index buffer form one triangle. Results are written into caller-owned
+        // spans, and the work is spread over the given executor. Per-triangle kernels gather the
+        // corners of lane_block triangles into component rows and run the cross products,
+        // lengths, normalization and tangent frames as lane loops over those rows.
+        //
+        // Per-vertex results gather from the triangles around each vertex (see Adjacency)
+        // instead of scattering from triangles into vertices, so workers never write to the
+        // same element and no atomics or per-thread copies of the output are needed. The per
+        // triangle terms are computed once, triangle-parallel, into a caller-owned faces span
+        // (reuse it across frames) before the per-vertex gather reads them back.
+
+        // Triangles incident to every vertex, in compressed row form.
+        // Build once per topology and reuse it while only the positions change.
+        class Adjacency
+        {
+            public:
+                using size_type = std::size_t;
+
+            public:
+                Adjacency() = default;
+
+                Adjacency(std::span<const std::uint32_t> indices, size_type vertex_count)
+                {
+                    build(indices, vertex_count);
+                }
+
+                void build(std::span<const std::uint32_t> indices, size_type vertex_count);
+
+                constexpr size_type vertex_count() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+                // Triangles touching vertex
+                std::span<const std::uint32_t> triangles(size_type vertex) const
+                {
+                    assert(vertex < vertex_count()); //"[ERROR] Invalid index"
+
+                    return { triangles_.data() + offsets_[vertex], triangles_.data() + offsets_[vertex + 1] };
+                }
+
+            private:
+                std::vector<size_type>     offsets_;
+                std::vector<std::uint32_t> triangles_;
+                std::vector<size_type>     fill_;
+        };
+
+        template <typename T>
+        void face_normals(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                          std::span<Vec::vec<3ULL, T>> out, Parallel::Executor& executor = Parallel::default_executor());
+
+        template <typename T>
+        void face_areas(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                        std::span<T> out, Parallel::Executor& executor = Parallel::default_executor());
+
+        template <typename T>
+        T surface_area(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                       Parallel::Executor& executor = Parallel::default_executor());
+
+        // Unnormalized triangle normals, their length is twice the triangle area
+        template <typename T>
+        void face_crosses(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                          std::span<Vec::vec<3ULL, T>> out, Parallel::Executor& executor = Parallel::default_executor());
+
+        // Area weighted: every triangle contributes its unnormalized cross product.
+        // faces (one per triangle) is left holding the output of face_crosses().
+        template <typename T>
+        void vertex_normals(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                            const Adjacency& adjacency, std::span<Vec::vec<3ULL, T>> faces, std::span<Vec::vec<3ULL, T>> out,
+                            Parallel::Executor& executor = Parallel::default_executor());
+
+        // Per-vertex tangents from texture coordinates, orthogonalized against normals.
+        // The fourth component holds the bitangent sign (+1 or -1).
+        // faces (two per triangle) is left holding the tangent and bitangent of every triangle.
+        template <typename T>
+        void vertex_tangents(std::span<const Vec::vec<3ULL, T>> positions, std::span<const Vec::vec<3ULL, T>> normals,
+                             std::span<const Vec::vec<2ULL, T>> uvs, std::span<const std::uint32_t> indices,
+                             const Adjacency& adjacency, std::span<Vec::vec<3ULL, T>> faces, std::span<Vec::vec<4ULL, T>> out,
+                             Parallel::Executor& executor = Parallel::default_executor());
+
+        //////////////////////////////////////////// Helpers //////////////////////////////////////////////////////////
+
+        // Smallest range handed to one task
+        constexpr inline std::size_t triangle_grain = 4096ULL;
+        constexpr inline std::size_t vertex_grain   = 2048ULL;
+
+        // Triangles gathered into one structure-of-arrays block
+        constexpr inline std::size_t lane_block = 64ULL;
+
+        // D rows of lane_block values, rows[idx][lane] is component idx of the lane's vector
+        template <typename T, std::size_t D = 3ULL>
+        using LaneRows = std::array<std::array<T, lane_block>, D>;
+
+        // Corner (0, 1 or 2) of triangles [first, first + width), gathered through the index buffer
+        template <std::size_t D, typename T>
+        inline void block_gather(std::span<const Vec::vec<D, T>> points, std::span<const std::uint32_t> indices,
+                                 std::size_t first, std::size_t width, std::size_t corner, LaneRows<T, D>& out)
+        {
+            for (std::size_t lane{}; lane < width; ++lane)
+            {
+                const auto& point = points[indices[3 * (first + lane) + corner]];
+
+                for (std::size_t idx{}; idx < D; ++idx)
+                    out[idx][lane] = point[idx];
+            }
+        }
+
+        // Edges from the first corner to the other two of triangles [first, first + width)
+        template <std::size_t D, typename T>
+        inline void block_edges(std::span<const Vec::vec<D, T>> points, std::span<const std::uint32_t> indices,
+                                std::size_t first, std::size_t width, LaneRows<T, D>& e1, LaneRows<T, D>& e2)
+        {
+            LaneRows<T, D> origin;
+
+            block_gather(points, indices, first, width, 0, origin);
+            block_gather(points, indices, first, width, 1, e1);
+            block_gather(points, indices, first, width, 2, e2);
+
+            for (std::size_t idx{}; idx < D; ++idx)
+                for (std::size_t lane{}; lane < width; ++lane)
+                {
+                    e1[idx][lane] -= origin[idx][lane];
+                    e2[idx][lane] -= origin[idx][lane];
+                }
+        }
+
+        // Unnormalized normals of triangles [first, first + width), one per lane; their length is
+        // twice the triangle area. The corners are gathered up front, so the edges and cross
+        // products are straight loops over the lanes.
+        template <typename T>
+        inline void block_crosses(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                                  std::size_t first, std::size_t width, LaneRows<T>& cross)
+        {
+            LaneRows<T> e1;
+            LaneRows<T> e2;
+
+            block_edges(positions, indices, first, width, e1, e2);
+
+            for (std::size_t lane{}; lane < width; ++lane)
+            {
+                cross[0][lane] = e1[1][lane] * e2[2][lane] - e1[2][lane] * e2[1][lane];
+                cross[1][lane] = -(e1[0][lane] * e2[2][lane] - e1[2][lane] * e2[0][lane]);
+                cross[2][lane] = e1[0][lane] * e2[1][lane] - e1[1][lane] * e2[0][lane];
+            }
+        }
+
+        // Length in T of every lane. The sqrt loop only vectorizes without errno handling
+        // (-fno-math-errno, set by the CMake target)
+        template <typename T>
+        inline void block_lengths(const LaneRows<T>& rows, std::size_t width, std::array<T, lane_block>& out)
+        {
+            for (std::size_t lane{}; lane < width; ++lane)
+                out[lane] = std::sqrt(rows[0][lane] * rows[0][lane] + rows[1][lane] * rows[1][lane] + rows[2][lane] * rows[2][lane]);
+        }
+
+        // Copy the lanes out to out[(first + lane) * stride + offset] of a vec<3, T> array
+        template <typename T>
+        inline void block_store(const LaneRows<T>& rows, std::size_t first, std::size_t width, std::span<Vec::vec<3ULL, T>> out,
+                                std::size_t stride = 1, std::size_t offset = 0)
+        {
+            for (std::size_t lane{}; lane < width; ++lane)
+                for (std::size_t idx{}; idx < 3ULL; ++idx)
+                    out[(first + lane) * stride + offset][idx] = rows[idx][lane];
+        }
+
+        // func(first, width) over blocks of at most lane_block triangles covering [begin, end)
+        template <typename F>
+        inline void for_each_block(std::size_t begin, std::size_t end, F&& func)
+        {
+            for (std::size_t first{ begin }; first < end; first += lane_block)
+                func(first, std::min(lane_block, end - first));
+        }
+
+        //////////////////////////////////////////// Adjacency ////////////////////////////////////////////////////////
+
+        inline void Adjacency::build(std::span<const std::uint32_t> indices, size_type vertex_count)
+        {
+            assert(indices.size() % 3 == 0); //"[ERROR] Index buffer is not a triangle list"
+
+            offsets_.assign(vertex_count + 1, 0);
+
+            for (const auto index : indices)
+            {
+                assert(index < vertex_count); //"[ERROR] Invalid index"
+                ++offsets_[index + 1];
+            }
+
+            std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+            fill_.assign(offsets_.begin(), offsets_.end() - 1);
+            triangles_.resize(indices.size());
+
+            for (size_type corner{}; corner < indices.size(); ++corner)
+                triangles_[fill_[indices[corner]]++] = static_cast<std::uint32_t>(corner / 3);
+        }
+
+        //////////////////////////////////////////// Kernels //////////////////////////////////////////////////////////
+
+        template <typename T>
+        void face_normals(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                          std::span<Vec::vec<3ULL, T>> out, Parallel::Executor& executor)
+        {
+            assert(indices.size() % 3 == 0);          //"[ERROR] Index buffer is not a triangle list"
+            assert(out.size() == indices.size() / 3); //"[ERROR] One output per triangle"
+
+            Parallel::parallel_for(executor, 0, out.size(), triangle_grain, [&](std::size_t begin, std::size_t end)
+            {
+                for_each_block(begin, end, [&](std::size_t first, std::size_t width)
+                {
+                    LaneRows<T> cross;
+                    std::array<T, lane_block> len;
+
+                    block_crosses(positions, indices, first, width, cross);
+                    block_lengths(cross, width, len);
+
+                    // Zero crosses are left as they are
+                    for (std::size_t lane{}; lane < width; ++lane)
+                        len[lane] = (len[lane] > T{}) ? len[lane] : T{ 1 };
+
+                    for (std::size_t idx{}; idx < 3ULL; ++idx)
+                        for (std::size_t lane{}; lane < width; ++lane)
+                            cross[idx][lane] /= len[lane];
+
+                    block_store(cross, first, width, out);
+                });
+            });
+        }
+
+        template <typename T>
+        void face_areas(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                        std::span<T> out, Parallel::Executor& executor)
+        {
+            assert(indices.size() % 3 == 0);          //"[ERROR] Index buffer is not a triangle list"
+            assert(out.size() == indices.size() / 3); //"[ERROR] One output per triangle"
+
+            Parallel::parallel_for(executor, 0, out.size(), triangle_grain, [&](std::size_t begin, std::size_t end)
+            {
+                for_each_block(begin, end, [&](std::size_t first, std::size_t width)
+                {
+                    LaneRows<T> cross;
+                    std::array<T, lane_block> len;
+
+                    block_crosses(positions, indices, first, width, cross);
+                    block_lengths(cross, width, len);
+
+                    for (std::size_t lane{}; lane < width; ++lane)
+                        out[first + lane] = len[lane] / T{ 2 };
+                });
+            });
+        }
+
+        template <typename T>
+        T surface_area(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                       Parallel::Executor& executor)
+        {
+            assert(indices.size() % 3 == 0); //"[ERROR] Index buffer is not a triangle list"
+
+            const T sum = Parallel::parallel_reduce(executor, 0, indices.size() / 3, triangle_grain, T{},
+                [&](std::size_t begin, std::size_t end)
+                {
+                    T partial{};
+
+                    for_each_block(begin, end, [&](std::size_t first, std::size_t width)
+                    {
+                        LaneRows<T> cross;
+                        std::array<T, lane_block> len;
+
+                        block_crosses(positions, indices, first, width, cross);
+                        block_lengths(cross, width, len);
+
+                        for (std::size_t lane{}; lane < width; ++lane)
+                            partial += len[lane];
+                    });
+
+                    return partial;
+                },
+                [](T lhs, T rhs) { return lhs + rhs; });
+
+            return sum / T{ 2 };
+        }
+
+        template <typename T>
+        void face_crosses(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                          std::span<Vec::vec<3ULL, T>> out, Parallel::Executor& executor)
+        {
+            assert(indices.size() % 3 == 0);          //"[ERROR] Index buffer is not a triangle list"
+            assert(out.size() == indices.size() / 3); //"[ERROR] One output per triangle"
+
+            Parallel::parallel_for(executor, 0, out.size(), triangle_grain, [&](std::size_t begin, std::size_t end)
+            {
+                for_each_block(begin, end, [&](std::size_t first, std::size_t width)
+                {
+                    LaneRows<T> cross;
+
+                    block_crosses(positions, indices, first, width, cross);
+                    block_store(cross, first, width, out);
+                });
+            });
+        }
+
+        template <typename T>
+        void vertex_normals(std::span<const Vec::vec<3ULL, T>> positions, std::span<const std::uint32_t> indices,
+                            const Adjacency& adjacency, std::span<Vec::vec<3ULL, T>> faces, std::span<Vec::vec<3ULL, T>> out,
+                            Parallel::Executor& executor)
+        {
+            assert(adjacency.vertex_count() == positions.size()); //"[ERROR] Adjacency built for another mesh"
+            assert(out.size() == positions.size());                //"[ERROR] One output per vertex"
+
+            face_crosses(positions, indices, faces, executor);
+
+            Parallel::parallel_for(executor, 0, out.size(), vertex_grain, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t vertex{ begin }; vertex < end; ++vertex)
+                {
+                    Vec::vec<3ULL, T> normal{};
+
+                    for (const auto triangle : adjacency.triangles(vertex))
+                        normal += faces[triangle];
+
+                    out[vertex] = Vec::Kernels::normalize(normal);
+                }
+            });
+        }
+
+        template <typename T>
+        void vertex_tangents(std::span<const Vec::vec<3ULL, T>> positions, std::span<const Vec::vec<3ULL, T>> normals,
+                             std::span<const Vec::vec<2ULL, T>> uvs, std::span<const std::uint32_t> indices,
+                             const Adjacency& adjacency, std::span<Vec::vec<3ULL, T>> faces, std::span<Vec::vec<4ULL, T>> out,
+                             Parallel::Executor& executor)
+        {
+            assert(indices.size() % 3 == 0);                      //"[ERROR] Index buffer is not a triangle list"
+            assert(adjacency.vertex_count() == positions.size()); //"[ERROR] Adjacency built for another mesh"
+            assert(normals.size() == positions.size() && uvs.size() == positions.size());
+            assert(faces.size() == 2 * (indices.size() / 3));     //"[ERROR] Two face entries per triangle"
+            assert(out.size() == positions.size());                //"[ERROR] One output per vertex"
+
+            Parallel::parallel_for(executor, 0, indices.size() / 3, triangle_grain, [&](std::size_t begin, std::size_t end)
+            {
+                for_each_block(begin, end, [&](std::size_t first, std::size_t width)
+                {
+                    LaneRows<T> e1;
+                    LaneRows<T> e2;
+                    LaneRows<T, 2ULL> d1; // (du, dv) of the first edge
+                    LaneRows<T, 2ULL> d2;
+
+                    block_edges(positions, indices, first, width, e1, e2);
+                    block_edges(uvs, indices, first, width, d1, d2);
+
+                    std::array<T, lane_block> inv;
+
+                    // Degenerate mapping, the triangle says nothing about the tangent frame: inv is 0.
+                    // Written as a division by det or 1 so the lane loop has no branch.
+                    for (std::size_t lane{}; lane < width; ++lane)
+                    {
+                        const T det = d1[0][lane] * d2[1][lane] - d2[0][lane] * d1[1][lane];
+
+                        const T degenerate = (det == T{}) ? T{ 1 } : T{};
+
+                        inv[lane] = (T{ 1 } - degenerate) / (det + degenerate);
+                    }
+
+                    LaneRows<T> tangent;
+                    LaneRows<T> bitangent;
+
+                    for (std::size_t idx{}; idx < 3ULL; ++idx)
+                        for (std::size_t lane{}; lane < width; ++lane)
+                        {
+                            tangent[idx][lane]   = (e1[idx][lane] * d2[1][lane] - e2[idx][lane] * d1[1][lane]) * inv[lane];
+                            bitangent[idx][lane] = (e2[idx][lane] * d1[0][lane] - e1[idx][lane] * d2[0][lane]) * inv[lane];
+                        }
+
+                    block_store(tangent, first, width, faces, 2, 0);
+                    block_store(bitangent, first, width, faces, 2, 1);
+                });
+            });
+
+            Parallel::parallel_for(executor, 0, out.size(), vertex_grain, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t vertex{ begin }; vertex < end; ++vertex)
+                {
+                    Vec::vec<3ULL, T> tangent{};
+                    Vec::vec<3ULL, T> bitangent{};
+
+                    for (const auto triangle : adjacency.triangles(vertex))
+                    {
+                        tangent   += faces[2 * triangle];
+                        bitangent += faces[2 * triangle + 1];
+                    }
+
+                    // Gram-Schmidt against the normal
+                    const auto& normal = normals[vertex];
+                    const T along = Vec::Kernels::accumulate<3ULL, T>([&](std::size_t idx) { return normal[idx] * tangent[idx]; });
+
+                    Vec::Kernels::for_each<3ULL>([&](std::size_t idx) { tangent[idx] -= normal[idx] * along; });
+                    Vec::Kernels::normalize(tangent);
+
+                    const Vec::vec<3ULL, T> side = normal.cross_product(tangent);
+                    const T handedness = Vec::Kernels::accumulate<3ULL, T>([&](std::size_t idx) { return side[idx] * bitangent[idx]; });
+
+                    out[vertex] = Vec::vec<4ULL, T>{ std::array<T, 4ULL>{ tangent[0], tangent[1], tangent[2], handedness < T{} ? T{ -1 } : T{ 1 } } };
+                }
+            });
+        }
+    }
+}
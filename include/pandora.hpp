@@ -2,3 +2,8 @@
 
 #include <vec.hpp>
 #include <mat.hpp>
+#include <mat_batch.hpp>
+#include <executor.hpp>
+#include <anim.hpp>
+#include <broadphase.hpp>
+#include <mesh.hpp>
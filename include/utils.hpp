@@ -1,6 +1,10 @@
 #pragma once
 
 #include <type_traits>
+#include <cstdint>
+#include <cmath>
+#include <iterator>
+#include <thread>
 
 namespace Pandora
 {
@@ -46,6 +50,14 @@ namespace Pandora
         template <std::size_t N, ::size_t V, std::size_t W>
         constexpr inline bool is_RN_v = (V == N && W == N) ? true : false;
 
+        // Hardware threads available, at least one
+        inline unsigned default_threads()
+        {
+            const unsigned hw = std::thread::hardware_concurrency();
+
+            return hw == 0u ? 1u : hw;
+        }
+
         template<typename T>
         struct sqrt
         {
@@ -8,6 +8,7 @@
 #include <cassert>
 #include <type_traits>
 #include <utils.hpp>
+#include <vec_kernels.hpp>
 
 namespace Pandora
 {
@@ -244,6 +245,10 @@ namespace Pandora
                 template <typename = std::enable_if_t<std::is_convertible_v<T, float>>>
                 constexpr inline float magnitude() const;
 
+                // Reassociated sum, faster for large N but can differ from magnitude() in the last bits
+                template <typename = std::enable_if_t<std::is_convertible_v<T, float>>>
+                constexpr inline float magnitude(Kernels::lanes_t) const;
+
                 template <typename = std::enable_if_t<Utils::is_fp_v<T> || Utils::is_uint_v<T> || Utils::is_int_v<T>>,
                          typename = std::enable_if_t<(N > 0ULL)>>
                 constexpr inline vec& normalize();
@@ -258,12 +263,24 @@ namespace Pandora
                           typename = std::enable_if_t<std::is_convertible_v<U, float>>>
                 constexpr inline float distance(const vec<Sz, U>&) const;
 
+                template <std::size_t Sz, typename U,
+                          typename = std::enable_if_t<Sz == N>,
+                          typename = std::enable_if_t<std::is_convertible_v<T, float>>,
+                          typename = std::enable_if_t<std::is_convertible_v<U, float>>>
+                constexpr inline float distance(const vec<Sz, U>&, Kernels::lanes_t) const;
+
                 template <std::size_t Sz, typename U,
                          typename = std::enable_if_t<Sz == N>,
                          typename = std::enable_if_t<std::is_convertible_v<T, float>>,
                          typename = std::enable_if_t<std::is_convertible_v<U, float>>>
                 constexpr inline float dot(const vec<Sz, U>&) const;
 
+                template <std::size_t Sz, typename U,
+                         typename = std::enable_if_t<Sz == N>,
+                         typename = std::enable_if_t<std::is_convertible_v<T, float>>,
+                         typename = std::enable_if_t<std::is_convertible_v<U, float>>>
+                constexpr inline float dot(const vec<Sz, U>&, Kernels::lanes_t) const;
+
                 template <std::size_t Sz, typename U,
                           typename = std::enable_if_t<Sz == N>,
                           typename = std::enable_if_t<Utils::is_R2_v<N, Sz> || Utils::is_R3_v<N, Sz>>,
@@ -310,8 +327,7 @@ namespace Pandora
             template <std::size_t Sz, typename U, typename, typename>
         constexpr inline vec<N, T>& vec<N, T>::operator+= (const vec<Sz, U>& obj)
         {
-            for(std::size_t count{}; count < N; ++count)
-                this->components[count] += obj.components[count];
+            Kernels::for_each<N>([&](std::size_t count) { this->components[count] += obj.components[count]; });
 
             return *this;
         }
@@ -320,8 +336,7 @@ namespace Pandora
             template <std::size_t Sz, typename U, typename, typename>
         constexpr inline vec<N, T>& vec<N, T>::operator-= (const vec<Sz, U>& obj)
         {
-            for(std::size_t count{}; count < N; ++count)
-                this->components[count] -= obj.components[count];
+            Kernels::for_each<N>([&](std::size_t count) { this->components[count] -= obj.components[count]; });
 
             return *this;
         }
@@ -330,8 +345,7 @@ namespace Pandora
             template <typename>
         constexpr inline vec<N, T>& vec<N, T>::operator*= (const float scl)
         {
-            for (auto& elem : *this)
-                elem *= scl;
+            Kernels::for_each<N>([&](std::size_t count) { this->components[count] *= scl; });
 
             return *this;
         }
@@ -340,8 +354,7 @@ namespace Pandora
             template <typename>
         constexpr inline vec<N, T>& vec<N, T>::operator /= (const float scl)
         {
-            for (auto& elem : *this)
-                elem /= scl;
+            Kernels::for_each<N>([&](std::size_t count) { this->components[count] /= scl; });
 
             return *this;
         }
@@ -367,11 +380,7 @@ namespace Pandora
         template <std::size_t Sz, typename U>
         constexpr inline bool operator== (const vec<Sz, U>& lhs, const vec<Sz, U>& rhs)
         {
-            for(std::size_t count{}; count < Sz; ++count)
-                if (lhs.components[count] != rhs.components[count])
-                    return false;
-
-            return true;
+            return Kernels::all_of<Sz>([&](std::size_t count) { return !(lhs.components[count] != rhs.components[count]); });
         }
 
         template <std::size_t Sz, typename U>
@@ -462,10 +471,19 @@ namespace Pandora
             if (this->is_zero_vec())
                 return 0.0f;
 
-            float mag{};
+            const float mag = Kernels::accumulate<N, float>([&](std::size_t idx) { return components[idx] * components[idx]; });
 
-            for(auto elem : components)
-                mag += (elem * elem);
+            return Utils::sqrt<float>{}(mag);
+        }
+
+        template <std::size_t N, typename T>
+            template <typename>
+        constexpr inline float vec<N, T>::magnitude(Kernels::lanes_t) const
+        {
+            if (this->is_zero_vec())
+                return 0.0f;
+
+            const float mag = Kernels::accumulate_lanes<N, float>([&](std::size_t idx) { return components[idx] * components[idx]; });
 
             return Utils::sqrt<float>{}(mag);
         }
@@ -493,10 +511,16 @@ namespace Pandora
             template <std::size_t Sz, typename U, typename, typename, typename>
         constexpr inline float vec<N, T>::distance(const vec<Sz, U>& obj) const
         {
-            float dist{};
+            const float dist = Kernels::accumulate<N, float>([&](size_type idx) { return POW2(obj.components[idx] - this->components[idx]); });
 
-            for(size_type idx{}; idx < N; ++idx)
-                dist += POW2(obj.components[idx] - this->components[idx]);
+            return Utils::sqrt<float>{}(dist);
+        }
+
+        template <std::size_t N, typename T>
+            template <std::size_t Sz, typename U, typename, typename, typename>
+        constexpr inline float vec<N, T>::distance(const vec<Sz, U>& obj, Kernels::lanes_t) const
+        {
+            const float dist = Kernels::accumulate_lanes<N, float>([&](size_type idx) { return POW2(obj.components[idx] - this->components[idx]); });
 
             return Utils::sqrt<float>{}(dist);
         }
@@ -505,12 +529,14 @@ namespace Pandora
             template <std::size_t Sz, typename U, typename, typename, typename>
         constexpr inline float vec<N, T>::dot(const vec<Sz, U>& obj) const
         {
-            float dot_product{};
-
-            for (std::size_t idx{}; idx < N; ++idx)
-                dot_product += this->components[idx] * obj.components[idx];
+            return Kernels::accumulate<N, float>([&](std::size_t idx) { return this->components[idx] * obj.components[idx]; });
+        }
 
-            return dot_product;
+        template <std::size_t N, typename T>
+            template <std::size_t Sz, typename U, typename, typename, typename>
+        constexpr inline float vec<N, T>::dot(const vec<Sz, U>& obj, Kernels::lanes_t) const
+        {
+            return Kernels::accumulate_lanes<N, float>([&](std::size_t idx) { return this->components[idx] * obj.components[idx]; });
         }
 
         template <std::size_t N, typename T>
@@ -556,7 +582,11 @@ namespace Pandora
         {
             t = BETWEEN_0_AND_1(t);
 
-            return vec{(1 - t) * (*this) - t*ovec};
+            vec result{};
+
+            Kernels::for_each<N>([&](std::size_t idx) { result.components[idx] = (1 - t) * this->components[idx] + t * ovec.components[idx]; });
+
+            return result;
         }
 
         template <std::size_t N, typename T>
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+namespace Pandora
+{
+    namespace Vec
+    {
+        // Component loops shared by every vec<N, T> operation.
+        // Small vectors (N <= unroll_limit) are expanded through an index sequence, so there is
+        // no loop left at all and constexpr callers fold to a constant. Larger vectors are walked
+        // in chunks of chunk_lanes components, which lets the compiler keep whole registers busy;
+        // the N % chunk_lanes remainder is handled by a tail.
+        // accumulate() always adds in index order, so sums round exactly as a plain loop does.
+        // accumulate_lanes() gives each lane its own accumulator instead, which is faster for
+        // large N but reassociates the sum; callers have to opt in to it (the vec reductions
+        // take Kernels::lanes for that).
+        namespace Kernels
+        {
+            constexpr inline std::size_t unroll_limit = 16ULL;
+            constexpr inline std::size_t chunk_lanes  = 32ULL;
+
+            template <std::size_t N>
+            constexpr inline bool is_unrolled_v = (N <= unroll_limit);
+
+            ///////////////////////////////////////////// Unrolled /////////////////////////////////////////////////
+
+            template <typename F, std::size_t ... I>
+            constexpr inline void for_each_unrolled(F&& func, std::index_sequence<I...>)
+            {
+                (func(I), ...);
+            }
+
+            template <typename P, std::size_t ... I>
+            constexpr inline bool all_of_unrolled(P&& pred, std::index_sequence<I...>)
+            {
+                return (pred(I) && ...);
+            }
+
+            // Left fold in index order, the same sequence of additions as a plain loop.
+            template <typename Acc, typename F, std::size_t ... I>
+            constexpr inline Acc accumulate_unrolled(F&& term, std::index_sequence<I...>)
+            {
+                Acc acc{};
+
+                ((acc += term(I)), ...);
+
+                return acc;
+            }
+
+            ///////////////////////////////////////////// Sequential ///////////////////////////////////////////////
+
+            template <std::size_t N, typename Acc, typename F>
+            constexpr inline Acc accumulate_sequential(F&& term)
+            {
+                Acc acc{};
+
+                for (std::size_t idx{}; idx < N; ++idx)
+                    acc += term(idx);
+
+                return acc;
+            }
+
+            ///////////////////////////////////////////// Chunked //////////////////////////////////////////////////
+
+            template <std::size_t N, typename F>
+            constexpr inline void for_each_chunked(F&& func)
+            {
+                constexpr std::size_t body = N - N % chunk_lanes;
+
+                for (std::size_t base{}; base < body; base += chunk_lanes)
+                    for (std::size_t lane{}; lane < chunk_lanes; ++lane)
+                        func(base + lane);
+
+                for (std::size_t idx{ body }; idx < N; ++idx)
+                    func(idx);
+            }
+
+            template <std::size_t N, typename P>
+            constexpr inline bool all_of_chunked(P&& pred)
+            {
+                constexpr std::size_t body = N - N % chunk_lanes;
+
+                // No early exit inside a chunk, so the lane compares stay branch free.
+                for (std::size_t base{}; base < body; base += chunk_lanes)
+                {
+                    bool chunk{ true };
+
+                    for (std::size_t lane{}; lane < chunk_lanes; ++lane)
+                        chunk &= static_cast<bool>(pred(base + lane));
+
+                    if (!chunk)
+                        return false;
+                }
+
+                for (std::size_t idx{ body }; idx < N; ++idx)
+                    if (!pred(idx))
+                        return false;
+
+                return true;
+            }
+
+            template <std::size_t N, typename Acc, typename F>
+            constexpr inline Acc accumulate_chunked(F&& term)
+            {
+                constexpr std::size_t body = N - N % chunk_lanes;
+
+                std::array<Acc, chunk_lanes> lanes{};
+
+                for (std::size_t base{}; base < body; base += chunk_lanes)
+                    for (std::size_t lane{}; lane < chunk_lanes; ++lane)
+                        lanes[lane] += term(base + lane);
+
+                // Pairwise reduction of the lanes
+                for (std::size_t width{ chunk_lanes / 2 }; width > 0; width /= 2)
+                    for (std::size_t lane{}; lane < width; ++lane)
+                        lanes[lane] += lanes[lane + width];
+
+                Acc tail{};
+
+                for (std::size_t idx{ body }; idx < N; ++idx)
+                    tail += term(idx);
+
+                return lanes[0] + tail;
+            }
+
+            ///////////////////////////////////////////// Dispatch /////////////////////////////////////////////////
+
+            // func(idx) for every idx in [0, N)
+            template <std::size_t N, typename F>
+            constexpr inline void for_each(F&& func)
+            {
+                if constexpr (is_unrolled_v<N>)
+                    for_each_unrolled(std::forward<F>(func), std::make_index_sequence<N>{});
+                else
+                    for_each_chunked<N>(std::forward<F>(func));
+            }
+
+            // true when pred(idx) holds for every idx in [0, N)
+            template <std::size_t N, typename P>
+            constexpr inline bool all_of(P&& pred)
+            {
+                if constexpr (is_unrolled_v<N>)
+                    return all_of_unrolled(std::forward<P>(pred), std::make_index_sequence<N>{});
+                else
+                    return all_of_chunked<N>(std::forward<P>(pred));
+            }
+
+            // Sum of term(idx) for every idx in [0, N), accumulated in Acc, added in index order
+            template <std::size_t N, typename Acc, typename F>
+            constexpr inline Acc accumulate(F&& term)
+            {
+                if constexpr (is_unrolled_v<N>)
+                    return accumulate_unrolled<Acc>(std::forward<F>(term), std::make_index_sequence<N>{});
+                else
+                    return accumulate_sequential<N, Acc>(std::forward<F>(term));
+            }
+
+            // Same sum as accumulate(), split over chunk_lanes accumulators once N fills a chunk.
+            // The additions are reassociated, so the result can differ in the last bits.
+            template <std::size_t N, typename Acc, typename F>
+            constexpr inline Acc accumulate_lanes(F&& term)
+            {
+                if constexpr (N < chunk_lanes)
+                    return accumulate<N, Acc>(std::forward<F>(term));
+                else
+                    return accumulate_chunked<N, Acc>(std::forward<F>(term));
+            }
+
+            // Passed to vec::dot, magnitude and distance to sum with accumulate_lanes()
+            struct lanes_t
+            {
+                explicit lanes_t() = default;
+            };
+
+            constexpr inline lanes_t lanes{};
+
+            ///////////////////////////////////////////// Precision ////////////////////////////////////////////////
+
+            // Length computed in T; vec::magnitude() always works in float
+            template <std::size_t N, typename T, template <std::size_t, typename> class V>
+            inline T length(const V<N, T>& obj)
+            {
+                return std::sqrt(accumulate<N, T>([&](std::size_t idx) { return obj[idx] * obj[idx]; }));
+            }
+
+            // Scale to unit length in T, zero vectors are left as they are
+            template <std::size_t N, typename T, template <std::size_t, typename> class V>
+            inline V<N, T>& normalize(V<N, T>& obj)
+            {
+                const T len = length(obj);
+
+                if (len > T{})
+                    for_each<N>([&](std::size_t idx) { obj[idx] /= len; });
+
+                return obj;
+            }
+        }
+    }
+}